@@ -0,0 +1,402 @@
+#include "FrameReplay.h"
+#include "ParseArguments.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <random>
+
+static const char* StageNames[ReplayStageCount] = { "Scene Update", "LOD Selection", "Draw Sorting", "Submission" };
+
+// Stands in for the D3D11 device context, the pipeline already counts what reaches it.
+class NullRenderContext : public RenderContext
+{
+public:
+    void set_input_layout(uint16_t) override {}
+    void set_vertex_shader(uint16_t) override {}
+    void set_pixel_shader(uint16_t) override {}
+    void set_vertex_buffer(uint16_t) override {}
+    void set_index_buffer(uint16_t) override {}
+    void draw_indexed(uint32_t, uint32_t) override {}
+};
+
+static void apply_changes(FramePipeline& pipeline, const CapturedFrame& frame)
+{
+    for (const SceneChange& change : frame.sceneChanges)
+        pipeline.apply_scene_change(change);
+    for (const DrawChange& change : frame.drawChanges)
+        pipeline.apply_draw_change(change);
+}
+
+void ReplayReport::print() const
+{
+    if (frameCount == 0) {
+        std::cout << "Replay: No frames were replayed.\n";
+        return;
+    }
+
+    double frames = double(frameCount);
+    std::cout << "Replay: " << frameCount << " frames\n";
+    for (int stage = 0; stage < ReplayStageCount; stage++) {
+        std::cout << "  " << StageNames[stage] << ": " << stages[stage].totalMilliseconds / frames << " ms avg, "
+            << stages[stage].maxMilliseconds << " ms max\n";
+    }
+    std::cout << "  Frame: " << totalMilliseconds / frames << " ms avg, " << maxFrameMilliseconds << " ms max\n";
+    if (allocationsCounted)
+        std::cout << "  Allocations: " << double(allocations) / frames << " per frame, " << double(allocatedBytes) / frames << " bytes per frame\n";
+    else
+        std::cout << "  Allocations: Not counted\n";
+    std::cout << "  State changes: " << double(stateChanges) / frames << " per frame\n";
+    std::cout << "  Draw calls: " << double(drawCalls) / frames << " per frame\n";
+}
+
+ReplayReport replay_capture(const FrameCapture& capture, uint32_t iterations, AllocationCounter allocationCounter)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    ReplayReport report;
+    report.allocationsCounted = allocationCounter != nullptr;
+
+    FramePipeline pipeline;
+    NullRenderContext context;
+    for (const std::vector<LODRange>& lods : capture.get_chains())
+        pipeline.add_chain(lods);
+
+    const std::vector<CapturedFrame>& frames = capture.get_frames();
+
+    // Untimed warm up so the pipeline's storage reaches its steady state capacity.
+    for (const CapturedFrame& frame : frames) {
+        apply_changes(pipeline, frame);
+        pipeline.begin_frame(frame.camera);
+        pipeline.select_lods();
+        pipeline.sort_draws();
+        pipeline.submit(context);
+    }
+
+    for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+        pipeline.clear_scene();
+
+        for (const CapturedFrame& frame : frames) {
+            AllocationStats allocationsBefore;
+            if (allocationCounter != nullptr)
+                allocationsBefore = allocationCounter();
+
+            Clock::time_point times[ReplayStageCount + 1];
+            times[0] = Clock::now();
+            apply_changes(pipeline, frame);
+            times[1] = Clock::now();
+            pipeline.begin_frame(frame.camera);
+            pipeline.select_lods();
+            times[2] = Clock::now();
+            pipeline.sort_draws();
+            times[3] = Clock::now();
+            pipeline.submit(context);
+            times[4] = Clock::now();
+
+            if (allocationCounter != nullptr) {
+                AllocationStats allocationsAfter = allocationCounter();
+                report.allocations += allocationsAfter.count - allocationsBefore.count;
+                report.allocatedBytes += allocationsAfter.bytes - allocationsBefore.bytes;
+            }
+
+            for (int stage = 0; stage < ReplayStageCount; stage++) {
+                double milliseconds = std::chrono::duration<double, std::milli>(times[stage + 1] - times[stage]).count();
+                report.stages[stage].totalMilliseconds += milliseconds;
+                report.stages[stage].maxMilliseconds = std::max(report.stages[stage].maxMilliseconds, milliseconds);
+            }
+
+            double frameMilliseconds = std::chrono::duration<double, std::milli>(times[ReplayStageCount] - times[0]).count();
+            report.totalMilliseconds += frameMilliseconds;
+            report.maxFrameMilliseconds = std::max(report.maxFrameMilliseconds, frameMilliseconds);
+            report.frameCount++;
+
+            const SubmitStats& stats = pipeline.get_submit_stats();
+            report.stateChanges += stats.stateChanges;
+            report.drawCalls += stats.drawCalls;
+        }
+    }
+
+    return report;
+}
+
+bool check_thresholds(const ReplayReport& report, const ReplayThresholds& thresholds)
+{
+    // A replay without frames measured nothing, so it cannot pass.
+    if (report.frameCount == 0) {
+        std::cout << "Replay Regression: No frames were replayed.\n";
+        return false;
+    }
+
+    bool passed = true;
+    double frames = double(report.frameCount);
+
+    auto check = [&](const char* name, double value, double limit) {
+        if (limit < 0.0 || value <= limit)
+            return;
+
+        std::cout << "Replay Regression: " << name << " averaged " << value << " per frame, threshold is " << limit << ".\n";
+        passed = false;
+    };
+
+    check("Frame time (ms)", report.totalMilliseconds / frames, thresholds.maxFrameMilliseconds);
+    for (int stage = 0; stage < ReplayStageCount; stage++)
+        check(StageNames[stage], report.stages[stage].totalMilliseconds / frames, thresholds.maxStageMilliseconds[stage]);
+    if (thresholds.maxAllocations >= 0.0 && !report.allocationsCounted) {
+        std::cout << "Replay Regression: An allocation threshold was set but allocations were not counted.\n";
+        passed = false;
+    }
+    check("Allocations", double(report.allocations) / frames, thresholds.maxAllocations);
+    check("State changes", double(report.stateChanges) / frames, thresholds.maxStateChanges);
+
+    return passed;
+}
+
+FrameCapture generate_synthetic_capture(uint32_t frameCount, uint32_t instanceCount, uint32_t seed)
+{
+    // Only raw mt19937 output is used, the standard distributions differ between library vendors.
+    std::mt19937 random(seed);
+    auto random_float = [&](float low, float high) {
+        return low + (high - low) * float(random() & 0xFFFFFF) / float(0x1000000);
+    };
+
+    // The synthetic scene is built through a pipeline like a real recording would be.
+    FramePipeline pipeline;
+    FrameCapture capture;
+    pipeline.start_capture(&capture);
+
+    // Each chain's LODs halve the index count of the previous one, like generate_lod_chain.
+    const uint32_t chainCount = 4;
+    for (uint32_t chain = 0; chain < chainCount; chain++) {
+        std::vector<LODRange> lods;
+        LODRange lod;
+        lod.indexCount = 30000 * (chain + 1);
+        for (uint32_t i = 0; i < 6; i++) {
+            lods.push_back(lod);
+            lod.firstIndex += lod.indexCount;
+            lod.indexCount /= 2;
+            lod.error = lod.error == 0.0f ? 0.005f * float(chain + 1) : lod.error * 2.0f;
+        }
+        pipeline.add_chain(lods);
+    }
+
+    std::vector<SceneChange> instances(instanceCount);
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        instances[i].type = SceneChange::AddInstance;
+        instances[i].instance = i;
+        instances[i].chain = i % chainCount;
+        instances[i].center = DirectX::XMFLOAT3(random_float(-500.0f, 500.0f), random_float(0.0f, 20.0f), random_float(-500.0f, 500.0f));
+        instances[i].radius = random_float(0.5f, 4.0f);
+        pipeline.apply_scene_change(instances[i]);
+
+        DrawChange draw;
+        draw.draw = i;
+        draw.submission.instance = i;
+        draw.submission.vertexBuffer = uint16_t(i % chainCount);
+        draw.submission.indexBuffer = uint16_t(i % chainCount);
+        draw.submission.pixelShader = uint16_t(i % 3);
+        pipeline.apply_draw_change(draw);
+    }
+
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        if (frame > 0 && instanceCount > 0) {
+            // Move roughly one percent of the scene every frame.
+            for (uint32_t i = 0; i < instanceCount / 100; i++) {
+                SceneChange& change = instances[random() % instanceCount];
+                change.type = SceneChange::MoveInstance;
+                change.center.x += random_float(-1.0f, 1.0f);
+                change.center.z += random_float(-1.0f, 1.0f);
+                pipeline.apply_scene_change(change);
+            }
+
+            // Swap the material of a few draws, which removes and re-adds them.
+            for (uint32_t i = 0; i < instanceCount / 1000; i++) {
+                DrawChange change;
+                change.draw = random() % instanceCount;
+                change.type = DrawChange::RemoveDraw;
+                pipeline.apply_draw_change(change);
+
+                change.type = DrawChange::AddDraw;
+                change.submission.instance = change.draw;
+                change.submission.vertexBuffer = uint16_t(change.draw % chainCount);
+                change.submission.indexBuffer = uint16_t(change.draw % chainCount);
+                change.submission.pixelShader = uint16_t(random() % 3);
+                pipeline.apply_draw_change(change);
+            }
+        }
+
+        // The camera orbits the scene at a 60 degree vertical field of view.
+        float angle = 6.2831853f * float(frame) / float(frameCount);
+        FrameCamera camera;
+        camera.position = DirectX::XMFLOAT3(std::cos(angle) * 300.0f, 30.0f, std::sin(angle) * 300.0f);
+        camera.projYY = 1.7320508f;
+        camera.viewportHeight = 900.0f;
+        pipeline.begin_frame(camera);
+    }
+
+    pipeline.stop_capture();
+    return capture;
+}
+
+template<typename T>
+static bool equal_arrays(const std::vector<T>& a, const std::vector<T>& b)
+{
+    // The capture structs are tightly packed, so comparing their bytes compares every field.
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+}
+
+bool check_capture_round_trip(const FrameCapture& capture, const char* capturePath)
+{
+    if (!capture.write(capturePath))
+        return false;
+
+    FrameCapture loaded;
+    if (!loaded.read(capturePath))
+        return false;
+
+    bool equal = capture.get_chains().size() == loaded.get_chains().size() && capture.get_frames().size() == loaded.get_frames().size();
+    for (size_t i = 0; equal && i < capture.get_chains().size(); i++)
+        equal = equal_arrays(capture.get_chains()[i], loaded.get_chains()[i]);
+    for (size_t i = 0; equal && i < capture.get_frames().size(); i++) {
+        const CapturedFrame& frame = capture.get_frames()[i];
+        const CapturedFrame& loadedFrame = loaded.get_frames()[i];
+        equal = memcmp(&frame.camera, &loadedFrame.camera, sizeof(FrameCamera)) == 0
+            && equal_arrays(frame.sceneChanges, loadedFrame.sceneChanges)
+            && equal_arrays(frame.drawChanges, loadedFrame.drawChanges);
+    }
+    if (!equal) {
+        std::cout << "Round Trip Error: Capture read back from \"" << capturePath << "\" differs from the one written.\n";
+        return false;
+    }
+
+    std::ifstream file(capturePath, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Cut inside the header, halfway and just before the end, every truncated file must be rejected.
+    std::string truncatedPath = std::string(capturePath) + ".truncated";
+    size_t truncatedSizes[] = { 8, bytes.size() / 2, bytes.size() - 1 };
+    for (size_t size : truncatedSizes) {
+        std::ofstream truncated(truncatedPath, std::ios::binary | std::ios::trunc);
+        truncated.write(bytes.data(), std::streamsize(size));
+        truncated.close();
+
+        std::cout << "Reading capture truncated to " << size << " of " << bytes.size() << " bytes, expecting an error:\n";
+        if (loaded.read(truncatedPath.c_str())) {
+            std::cout << "Round Trip Error: Capture truncated to " << size << " bytes was accepted.\n";
+            return false;
+        }
+    }
+
+    std::cout << "Round trip of \"" << capturePath << "\" passed.\n";
+    return true;
+}
+
+static bool parse_threshold(const char* argument, double& value)
+{
+    char* end = nullptr;
+    double parsed = strtod(argument, &end);
+    if (end == argument || *end != '\0' || !std::isfinite(parsed) || parsed < 0.0)
+        return false;
+
+    value = parsed;
+    return true;
+}
+
+static void print_replay_usage()
+{
+    std::cout << "Usage:\n"
+        << "  replay_benchmark --replay <capture> [--iterations N] [--max-frame-ms X] [--max-scene-ms X] [--max-lod-ms X]\n"
+        << "                   [--max-sort-ms X] [--max-submit-ms X] [--max-allocations X] [--max-state-changes X]\n"
+        << "  replay_benchmark --generate-capture <capture> [frames] [instances]\n"
+        << "  replay_benchmark --check-round-trip <capture> [frames] [instances]\n";
+}
+
+int run_replay_benchmark(int argc, char** argv, AllocationCounter allocationCounter)
+{
+    if (argc < 3) {
+        print_replay_usage();
+        return -1;
+    }
+
+    if (strcmp(argv[1], "--generate-capture") == 0 || strcmp(argv[1], "--check-round-trip") == 0) {
+        uint32_t frameCount = 300;
+        uint32_t instanceCount = 10000;
+        if ((argc > 3 && !parse_count(argv[3], frameCount)) || (argc > 4 && !parse_count(argv[4], instanceCount)) || argc > 5) {
+            print_replay_usage();
+            return -1;
+        }
+
+        FrameCapture capture = generate_synthetic_capture(frameCount, instanceCount);
+        if (strcmp(argv[1], "--check-round-trip") == 0)
+            return check_capture_round_trip(capture, argv[2]) ? 0 : 1;
+        return capture.write(argv[2]) ? 0 : -1;
+    }
+
+    if (strcmp(argv[1], "--replay") != 0) {
+        print_replay_usage();
+        return -1;
+    }
+
+    uint32_t iterations = 1;
+    ReplayThresholds thresholds;
+    for (int i = 3; i < argc; i += 2) {
+        const char* option = argv[i];
+        if (i + 1 == argc) {
+            std::cout << "Replay Error: Option \"" << option << "\" needs a value.\n";
+            print_replay_usage();
+            return -1;
+        }
+        const char* argument = argv[i + 1];
+
+        double* threshold = nullptr;
+        if (strcmp(option, "--iterations") == 0) {
+            if (!parse_count(argument, iterations)) {
+                std::cout << "Replay Error: --iterations needs a positive whole number, got \"" << argument << "\".\n";
+                return -1;
+            }
+            continue;
+        }
+        else if (strcmp(option, "--max-frame-ms") == 0)
+            threshold = &thresholds.maxFrameMilliseconds;
+        else if (strcmp(option, "--max-scene-ms") == 0)
+            threshold = &thresholds.maxStageMilliseconds[SceneUpdate];
+        else if (strcmp(option, "--max-lod-ms") == 0)
+            threshold = &thresholds.maxStageMilliseconds[LODSelection];
+        else if (strcmp(option, "--max-sort-ms") == 0)
+            threshold = &thresholds.maxStageMilliseconds[DrawSorting];
+        else if (strcmp(option, "--max-submit-ms") == 0)
+            threshold = &thresholds.maxStageMilliseconds[Submission];
+        else if (strcmp(option, "--max-allocations") == 0)
+            threshold = &thresholds.maxAllocations;
+        else if (strcmp(option, "--max-state-changes") == 0)
+            threshold = &thresholds.maxStateChanges;
+        else {
+            std::cout << "Replay Error: Unknown option \"" << option << "\".\n";
+            print_replay_usage();
+            return -1;
+        }
+
+        if (!parse_threshold(argument, *threshold)) {
+            std::cout << "Replay Error: " << option << " needs a non negative number, got \"" << argument << "\".\n";
+            return -1;
+        }
+    }
+
+    FrameCapture capture;
+    if (!capture.read(argv[2]))
+        return -1;
+    if (capture.get_frames().empty()) {
+        std::cout << "Replay Error: Capture \"" << argv[2] << "\" has no frames.\n";
+        return -1;
+    }
+
+    ReplayReport report = replay_capture(capture, iterations, allocationCounter);
+    report.print();
+
+    return check_thresholds(report, thresholds) ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FrameCapture.h"
+
+// Stages of the frame pipeline that are timed during replay.
+enum ReplayStage {
+	SceneUpdate,
+	LODSelection,
+	DrawSorting,
+	Submission,
+	ReplayStageCount
+};
+
+// Totals of the process wide heap traffic so far.
+struct AllocationStats {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+// Supplied by the executable, which counts allocations by replacing the global operator new.
+typedef AllocationStats (*AllocationCounter)();
+
+struct ReplayReport {
+	uint64_t frameCount = 0;
+	struct StageTiming {
+		double totalMilliseconds = 0.0;
+		double maxMilliseconds = 0.0;
+	} stages[ReplayStageCount];
+	double totalMilliseconds = 0.0;
+	double maxFrameMilliseconds = 0.0;
+
+	// Every heap allocation made during the timed stages, false if no counter was supplied.
+	bool allocationsCounted = false;
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+
+	// State changes the pipeline sent to the device after filtering out rebinds of bound state.
+	uint64_t stateChanges = 0;
+	uint64_t drawCalls = 0;
+
+	void print() const;
+};
+
+// Per frame averages a replay has to stay under, negative values are not checked.
+struct ReplayThresholds {
+	double maxFrameMilliseconds = -1.0;
+	double maxStageMilliseconds[ReplayStageCount] = { -1.0, -1.0, -1.0, -1.0 };
+	double maxAllocations = -1.0;
+	double maxStateChanges = -1.0;
+};
+
+// Runs every frame of the capture through FramePipeline against a null device. The capture is
+// replayed once untimed to warm up, then the scene is cleared and the capture is timed for the
+// requested number of iterations. Storage kept from the warm up is not counted as allocations.
+ReplayReport replay_capture(const FrameCapture& capture, uint32_t iterations = 1, AllocationCounter allocationCounter = nullptr);
+
+// Prints every exceeded threshold and returns false if any were, or if no frames were replayed.
+bool check_thresholds(const ReplayReport& report, const ReplayThresholds& thresholds);
+
+// Builds a deterministic capture of instances orbited by the camera, for when no recorded capture is available.
+FrameCapture generate_synthetic_capture(uint32_t frameCount, uint32_t instanceCount, uint32_t seed = 1);
+
+// Writes the capture, checks that reading it back gives the same chains and frames, and that
+// truncated copies of the file are rejected. Returns false on any mismatch.
+bool check_capture_round_trip(const FrameCapture& capture, const char* capturePath);
+
+// Command line entry point of the replay executable. Returns the process exit code.
+int run_replay_benchmark(int argc, char** argv, AllocationCounter allocationCounter);
@@ -0,0 +1,99 @@
+#include "MeshLOD.h"
+#include "ParseArguments.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double milliseconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Tessellated unit sphere with (segments + 1)^2 vertices and 2 * segments^2 triangles.
+static void build_sphere(uint32_t segments, std::vector<DirectX::XMFLOAT3>& positions, std::vector<uint32_t>& indices)
+{
+    const float pi = 3.14159265f;
+    for (uint32_t y = 0; y <= segments; y++) {
+        float v = pi * float(y) / float(segments);
+        for (uint32_t x = 0; x <= segments; x++) {
+            float u = 2.0f * pi * float(x) / float(segments);
+            positions.push_back(DirectX::XMFLOAT3(std::sin(v) * std::cos(u), std::cos(v), std::sin(v) * std::sin(u)));
+        }
+    }
+
+    for (uint32_t y = 0; y < segments; y++) {
+        for (uint32_t x = 0; x < segments; x++) {
+            uint32_t a = y * (segments + 1) + x, b = a + 1, c = a + segments + 1, d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+}
+
+// Usage: lod_benchmark [segments] [instances] [frames]
+int main(int argc, char** argv)
+{
+    uint32_t segments = 283;
+    uint32_t instanceCount = 1000000;
+    uint32_t frameCount = 100;
+
+    if ((argc > 1 && !parse_count(argv[1], segments)) || (argc > 2 && !parse_count(argv[2], instanceCount)) || (argc > 3 && !parse_count(argv[3], frameCount)) || argc > 4) {
+        std::cout << "Usage: lod_benchmark [segments] [instances] [frames], all positive integers.\n";
+        return -1;
+    }
+
+    // Simplification throughput
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<uint32_t> indices;
+    build_sphere(segments, positions, indices);
+
+    Clock::time_point start = Clock::now();
+    LODChain chain = generate_lod_chain(positions.data(), positions.size(), sizeof(DirectX::XMFLOAT3), indices);
+    double generateMilliseconds = milliseconds_since(start);
+
+    size_t inputTriangles = indices.size() / 3;
+    size_t removedTriangles = inputTriangles - chain.back().indices.size() / 3;
+    std::cout << "LOD Generation: " << inputTriangles << " triangles, " << chain.size() << " LODs in " << generateMilliseconds << " ms, "
+        << double(inputTriangles) / generateMilliseconds * 1000.0 << " input triangles/s\n";
+    for (size_t lod = 0; lod < chain.size(); lod++)
+        std::cout << "  LOD " << lod << ": " << chain[lod].indices.size() / 3 << " triangles, error " << chain[lod].error << "\n";
+    if (chain.size() < 2 || removedTriangles == 0) {
+        std::cout << "LOD Generation Error: The mesh was not simplified.\n";
+        return 1;
+    }
+
+    // Per frame selection over a grid of instances with the camera flying across it.
+    LODSelector selector;
+    uint32_t chainIndex = selector.add_chain(chain);
+
+    std::vector<LODInstance> instances(instanceCount);
+    uint32_t gridWidth = uint32_t(std::ceil(std::sqrt(double(instanceCount))));
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        instances[i].center = DirectX::XMFLOAT3(float(i % gridWidth) * 4.0f, 0.0f, float(i / gridWidth) * 4.0f);
+        instances[i].radius = 1.0f;
+        instances[i].chain = chainIndex;
+    }
+
+    double totalMilliseconds = 0.0, maxMilliseconds = 0.0;
+    uint64_t lodSum = 0;
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        DirectX::XMFLOAT3 camera(float(frame) * 2.0f, 10.0f, float(frame) * 2.0f);
+
+        start = Clock::now();
+        selector.select(camera, 1.7320508f, 900.0f, instances.data(), instances.size());
+        double frameMilliseconds = milliseconds_since(start);
+
+        totalMilliseconds += frameMilliseconds;
+        maxMilliseconds = std::max(maxMilliseconds, frameMilliseconds);
+        lodSum += instances[frame % instanceCount].lod;
+    }
+
+    std::cout << "LOD Selection: " << instanceCount << " instances, " << totalMilliseconds / frameCount << " ms avg, "
+        << maxMilliseconds << " ms max per frame (checksum " << lodSum << ")\n";
+
+    return 0;
+}
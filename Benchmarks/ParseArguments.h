@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+// Parses a positive whole number command line argument, rejecting trailing characters and signs.
+inline bool parse_count(const char* argument, uint32_t& value)
+{
+	char* end = nullptr;
+	unsigned long parsed = strtoul(argument, &end, 10);
+	if (end == argument || *end != '\0' || argument[0] == '-' || parsed == 0 || parsed > 0xFFFFFFFFul)
+		return false;
+
+	value = uint32_t(parsed);
+	return true;
+}
@@ -9,6 +9,14 @@ const char* get_glfw_error() {
 	return error;
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	Application* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+
+	if (key == GLFW_KEY_F9 && action == GLFW_PRESS)
+		app->toggle_capture();
+}
+
 bool Application::is_closing()
 {
 	return glfwWindowShouldClose(_window);
@@ -34,6 +42,7 @@ bool Application::init()
 
 	// Set the user point to use with input callbacks
 	glfwSetWindowUserPointer(_window, this);
+	glfwSetKeyCallback(_window, key_callback);
 
 	// Create an instance of the renderer
 	_renderer = std::make_unique<Renderer>(_window);
@@ -47,9 +56,24 @@ bool Application::init()
 	return true;
 }
 
+void Application::toggle_capture()
+{
+	if (_capture == nullptr) {
+		_capture = std::make_unique<FrameCapture>();
+		_renderer->set_capture(_capture.get());
+		std::cout << "Capture: Recording frames, press F9 to stop." << std::endl;
+		return;
+	}
+
+	_renderer->set_capture(nullptr);
+	if (_capture->write("frame_capture.gfcp"))
+		std::cout << "Capture: Wrote " << _capture->get_frames().size() << " frames to \"frame_capture.gfcp\"." << std::endl;
+	_capture = nullptr;
+}
+
 void Application::run()
 {
 	glfwPollEvents();
 
-	_renderer->draw();
+	_renderer->draw(_camera);
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include "Renderer.h"
+#include "Camera.h"
+#include "FrameCapture.h"
 
 #include <memory>
 
@@ -10,6 +12,9 @@ class Application
 private:
 	GLFWwindow* _window = nullptr;
 	std::unique_ptr<Renderer> _renderer = nullptr;
+	Camera _camera;
+	// Set while frames are being recorded, toggled with F9.
+	std::unique_ptr<FrameCapture> _capture = nullptr;
 
 public:
 	// Query functions
@@ -19,6 +24,9 @@ public:
 	bool init();
 	bool shutdown();
 
+	// Starts recording frames, or stops and writes them to frame_capture.gfcp.
+	void toggle_capture();
+
 	void run();
 };
 
@@ -1 +1,14 @@
 #include "Camera.h"
+
+#include <cmath>
+
+FrameCamera Camera::get_frame_camera(float viewportHeight) const
+{
+	FrameCamera frameCamera;
+	frameCamera.position = _position;
+	// [1][1] of the perspective projection matrix.
+	frameCamera.projYY = 1.0f / std::tan(_fovY * 0.5f);
+	frameCamera.viewportHeight = viewportHeight;
+
+	return frameCamera;
+}
@@ -1,10 +1,20 @@
 #pragma once
 
+#include "FramePipeline.h"
+
 #include <SimpleMath.h>
 using namespace DirectX;
 
 class Camera
 {
-	
-};
+private:
+	SimpleMath::Vector3 _position = SimpleMath::Vector3(0.0f, 0.0f, -5.0f);
+	float _fovY = XM_PIDIV4;
+
+public:
+	void set_position(const SimpleMath::Vector3& position) { _position = position; }
+	void set_fov(float fovY) { _fovY = fovY; }
 
+	// View parameters the frame pipeline selects LODs with.
+	FrameCamera get_frame_camera(float viewportHeight) const;
+};
\ No newline at end of file
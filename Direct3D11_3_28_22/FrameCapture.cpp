@@ -0,0 +1,168 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+// File layout, all values little endian:
+//   CaptureHeader
+//   per chain:  uint32_t lodCount, LODRange[lodCount]
+//   per frame:  FrameCamera, uint32_t sceneChangeCount, SceneChange[sceneChangeCount],
+//               uint32_t drawChangeCount, DrawChange[drawChangeCount]
+static const char CaptureMagic[4] = { 'G', 'F', 'C', 'P' };
+static const uint32_t CaptureVersion = 3;
+
+struct CaptureHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t chainCount;
+    uint32_t frameCount;
+};
+
+template<typename T>
+static void write_array(std::ofstream& file, const std::vector<T>& values)
+{
+    uint32_t count = uint32_t(values.size());
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    if (count > 0)
+        file.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * count);
+}
+
+// Reads count values, the count is checked against the bytes left in the file before any storage
+// is allocated for it, so a corrupt count fails instead of allocating gigabytes.
+template<typename T>
+static bool read_values(std::ifstream& file, uint64_t& bytesLeft, T* values, uint64_t count)
+{
+    uint64_t size = sizeof(T) * count;
+    if (size > bytesLeft)
+        return false;
+
+    bytesLeft -= size;
+    return count == 0 || bool(file.read(reinterpret_cast<char*>(values), std::streamsize(size)));
+}
+
+template<typename T>
+static bool read_array(std::ifstream& file, uint64_t& bytesLeft, std::vector<T>& values)
+{
+    uint32_t count = 0;
+    if (!read_values(file, bytesLeft, &count, 1) || uint64_t(count) * sizeof(T) > bytesLeft)
+        return false;
+
+    values.resize(count);
+    return read_values(file, bytesLeft, values.data(), count);
+}
+
+void FrameCapture::clear()
+{
+    _chains.clear();
+    _frames.clear();
+    _pending = CapturedFrame();
+}
+
+uint32_t FrameCapture::add_chain(const std::vector<LODRange>& lods)
+{
+    _chains.push_back(lods);
+    return uint32_t(_chains.size() - 1);
+}
+
+void FrameCapture::record_scene_change(const SceneChange& change)
+{
+    _pending.sceneChanges.push_back(change);
+}
+
+void FrameCapture::record_draw_change(const DrawChange& change)
+{
+    _pending.drawChanges.push_back(change);
+}
+
+void FrameCapture::begin_frame(const FrameCamera& camera)
+{
+    _pending.camera = camera;
+    _frames.push_back(std::move(_pending));
+    _pending = CapturedFrame();
+}
+
+bool FrameCapture::write(const char* capturePath) const
+{
+    std::ofstream file(capturePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Capture Error: Failed to open file \"" << capturePath << "\" for writing.\n";
+        return false;
+    }
+
+    CaptureHeader header = {};
+    std::copy(CaptureMagic, CaptureMagic + 4, header.magic);
+    header.version = CaptureVersion;
+    header.chainCount = uint32_t(_chains.size());
+    header.frameCount = uint32_t(_frames.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const std::vector<LODRange>& lods : _chains)
+        write_array(file, lods);
+
+    for (const CapturedFrame& frame : _frames) {
+        file.write(reinterpret_cast<const char*>(&frame.camera), sizeof(frame.camera));
+        write_array(file, frame.sceneChanges);
+        write_array(file, frame.drawChanges);
+    }
+
+    if (!file) {
+        std::cout << "Capture Error: Error while writing file \"" << capturePath << "\".\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool FrameCapture::read(const char* capturePath)
+{
+    clear();
+
+    std::ifstream file(capturePath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cout << "Capture Error: Failed to open file \"" << capturePath << "\".\n";
+        return false;
+    }
+
+    uint64_t bytesLeft = uint64_t(file.tellg());
+    file.seekg(0);
+
+    CaptureHeader header = {};
+    if (!read_values(file, bytesLeft, &header, 1) || !std::equal(CaptureMagic, CaptureMagic + 4, header.magic)) {
+        std::cout << "Capture Error: File \"" << capturePath << "\" is not a frame capture.\n";
+        return false;
+    }
+    if (header.version != CaptureVersion) {
+        std::cout << "Capture Error: File \"" << capturePath << "\" has unsupported version " << header.version << ".\n";
+        return false;
+    }
+
+    // Every chain and frame takes at least its counts and camera, which bounds both counts by the file size.
+    const uint64_t minChainSize = sizeof(uint32_t);
+    const uint64_t minFrameSize = sizeof(FrameCamera) + 2 * sizeof(uint32_t);
+    if (header.chainCount * minChainSize + header.frameCount * minFrameSize > bytesLeft) {
+        std::cout << "Capture Error: Error while loading file \"" << capturePath << "\".\n";
+        return false;
+    }
+
+    _chains.resize(header.chainCount);
+    for (std::vector<LODRange>& lods : _chains) {
+        if (!read_array(file, bytesLeft, lods)) {
+            std::cout << "Capture Error: Error while loading file \"" << capturePath << "\".\n";
+            clear();
+            return false;
+        }
+    }
+
+    _frames.resize(header.frameCount);
+    for (CapturedFrame& frame : _frames) {
+        if (!read_values(file, bytesLeft, &frame.camera, 1) || !read_array(file, bytesLeft, frame.sceneChanges) || !read_array(file, bytesLeft, frame.drawChanges)) {
+            std::cout << "Capture Error: Error while loading file \"" << capturePath << "\".\n";
+            clear();
+            return false;
+        }
+    }
+
+    return true;
+}
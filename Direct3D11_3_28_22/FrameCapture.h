@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "FramePipeline.h"
+
+// The scene and draw list persist across frames, so a frame only holds what changed since the
+// last one. The first frame of a capture adds everything that existed when recording started.
+struct CapturedFrame {
+	FrameCamera camera;
+	std::vector<SceneChange> sceneChanges;
+	std::vector<DrawChange> drawChanges;
+};
+
+// Records the high level inputs of each frame so they can be replayed deterministically.
+// Usually filled in by FramePipeline::start_capture.
+class FrameCapture
+{
+private:
+	std::vector<std::vector<LODRange>> _chains;
+	std::vector<CapturedFrame> _frames;
+	// Changes made since the last begin_frame, they belong to the next frame.
+	CapturedFrame _pending;
+
+public:
+	void clear();
+
+	// Chains are indexed in the order they are added, matching the FramePipeline they came from.
+	uint32_t add_chain(const std::vector<LODRange>& lods);
+
+	void record_scene_change(const SceneChange& change);
+	void record_draw_change(const DrawChange& change);
+	// Starts a new frame holding every change recorded since the previous one.
+	void begin_frame(const FrameCamera& camera);
+
+	bool write(const char* capturePath) const;
+	bool read(const char* capturePath);
+
+	const std::vector<std::vector<LODRange>>& get_chains() const { return _chains; }
+	const std::vector<CapturedFrame>& get_frames() const { return _frames; }
+};
@@ -0,0 +1,215 @@
+#include "FramePipeline.h"
+#include "FrameCapture.h"
+
+#include <algorithm>
+
+uint32_t FramePipeline::add_chain(const LODChain& chain, uint32_t firstIndex)
+{
+    std::vector<LODRange> lods;
+    lods.reserve(chain.size());
+    for (const MeshLOD& lod : chain) {
+        LODRange range;
+        range.error = lod.error;
+        range.firstIndex = firstIndex;
+        range.indexCount = uint32_t(lod.indices.size());
+        lods.push_back(range);
+
+        firstIndex += range.indexCount;
+    }
+
+    return add_chain(lods);
+}
+
+uint32_t FramePipeline::add_chain(const std::vector<LODRange>& lods)
+{
+    std::vector<float> errors;
+    errors.reserve(lods.size());
+    for (const LODRange& lod : lods)
+        errors.push_back(lod.error);
+
+    _selector.add_chain(errors);
+    _chains.push_back(lods);
+
+    if (_capture != nullptr)
+        _capture->add_chain(lods);
+
+    return uint32_t(_chains.size() - 1);
+}
+
+bool FramePipeline::apply_scene_change(const SceneChange& change)
+{
+    switch (change.type) {
+    case SceneChange::AddInstance: {
+        if (change.chain >= _chains.size())
+            return false;
+
+        LODInstance instance;
+        instance.center = change.center;
+        instance.radius = change.radius;
+        instance.chain = change.chain;
+        instance.lod = change.lod;
+        if (!_instances.insert(change.instance, instance))
+            return false;
+        break;
+    }
+    case SceneChange::RemoveInstance:
+        if (!_instances.erase(change.instance))
+            return false;
+        break;
+    case SceneChange::MoveInstance: {
+        LODInstance* instance = _instances.find(change.instance);
+        if (instance == nullptr)
+            return false;
+
+        instance->center = change.center;
+        instance->radius = change.radius;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (_capture != nullptr)
+        _capture->record_scene_change(change);
+
+    return true;
+}
+
+bool FramePipeline::apply_draw_change(const DrawChange& change)
+{
+    switch (change.type) {
+    case DrawChange::AddDraw:
+        if (!_draws.insert(change.draw, change.submission))
+            return false;
+        break;
+    case DrawChange::RemoveDraw:
+        if (!_draws.erase(change.draw))
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    if (_capture != nullptr)
+        _capture->record_draw_change(change);
+
+    return true;
+}
+
+void FramePipeline::clear_scene()
+{
+    _instances.clear();
+    _draws.clear();
+    _drawQueue.clear();
+}
+
+void FramePipeline::begin_frame(const FrameCamera& camera)
+{
+    _camera = camera;
+
+    if (_capture != nullptr)
+        _capture->begin_frame(camera);
+}
+
+void FramePipeline::select_lods()
+{
+    // Instances are kept dense, so only live instances are visited.
+    std::vector<LODInstance>& instances = _instances.get_items();
+    _selector.select(_camera.position, _camera.projYY, _camera.viewportHeight, instances.data(), instances.size());
+}
+
+void FramePipeline::sort_draws()
+{
+    _drawQueue.clear();
+    for (const DrawSubmission& draw : _draws.get_items()) {
+        const LODInstance* instance = _instances.find(draw.instance);
+        if (instance == nullptr)
+            continue;
+
+        const std::vector<LODRange>& lods = _chains[instance->chain];
+        if (lods.empty())
+            continue;
+
+        uint32_t lod = std::min(instance->lod, uint32_t(lods.size() - 1));
+
+        QueuedDraw queued;
+        queued.stateKey = (uint64_t(draw.vertexShader) << 48) | (uint64_t(draw.pixelShader) << 32) | (uint64_t(draw.inputLayout) << 16) | draw.vertexBuffer;
+        queued.bufferKey = (uint64_t(draw.indexBuffer) << 32) | lod;
+        queued.draw = draw;
+        queued.firstIndex = lods[lod].firstIndex;
+        queued.indexCount = lods[lod].indexCount;
+        _drawQueue.push_back(queued);
+    }
+
+    std::sort(_drawQueue.begin(), _drawQueue.end());
+}
+
+void FramePipeline::submit(RenderContext& context)
+{
+    _stats = SubmitStats();
+
+    // State is rebound on the first draw of every frame, after that only changes are sent.
+    struct BoundState {
+        uint32_t inputLayout = UINT32_MAX;
+        uint32_t vertexShader = UINT32_MAX;
+        uint32_t pixelShader = UINT32_MAX;
+        uint32_t vertexBuffer = UINT32_MAX;
+        uint32_t indexBuffer = UINT32_MAX;
+    } bound;
+
+    auto bind = [&](uint32_t& boundId, uint16_t id, void (RenderContext::*set)(uint16_t)) {
+        if (boundId == id)
+            return;
+
+        boundId = id;
+        (context.*set)(id);
+        _stats.stateChanges++;
+    };
+
+    for (const QueuedDraw& queued : _drawQueue) {
+        const DrawSubmission& draw = queued.draw;
+        bind(bound.inputLayout, draw.inputLayout, &RenderContext::set_input_layout);
+        bind(bound.vertexShader, draw.vertexShader, &RenderContext::set_vertex_shader);
+        bind(bound.pixelShader, draw.pixelShader, &RenderContext::set_pixel_shader);
+        bind(bound.vertexBuffer, draw.vertexBuffer, &RenderContext::set_vertex_buffer);
+        bind(bound.indexBuffer, draw.indexBuffer, &RenderContext::set_index_buffer);
+
+        context.draw_indexed(queued.indexCount, queued.firstIndex);
+        _stats.drawCalls++;
+    }
+}
+
+void FramePipeline::start_capture(FrameCapture* capture)
+{
+    _capture = capture;
+    if (_capture == nullptr)
+        return;
+
+    _capture->clear();
+
+    for (const std::vector<LODRange>& lods : _chains)
+        _capture->add_chain(lods);
+
+    const std::vector<uint32_t>& instanceIds = _instances.get_ids();
+    const std::vector<LODInstance>& instances = _instances.get_items();
+    for (size_t i = 0; i < instances.size(); i++) {
+        SceneChange change;
+        change.type = SceneChange::AddInstance;
+        change.instance = instanceIds[i];
+        change.chain = instances[i].chain;
+        change.center = instances[i].center;
+        change.radius = instances[i].radius;
+        change.lod = instances[i].lod;
+        _capture->record_scene_change(change);
+    }
+
+    const std::vector<uint32_t>& drawIds = _draws.get_ids();
+    const std::vector<DrawSubmission>& draws = _draws.get_items();
+    for (size_t i = 0; i < draws.size(); i++) {
+        DrawChange change;
+        change.type = DrawChange::AddDraw;
+        change.draw = drawIds[i];
+        change.submission = draws[i];
+        _capture->record_draw_change(change);
+    }
+}
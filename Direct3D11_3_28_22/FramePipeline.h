@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "MeshLOD.h"
+
+class FrameCapture;
+
+// Instance and draw ids index straight into lookup tables, so they are capped.
+const uint32_t MaxPipelineId = 1 << 24;
+
+// The structs below are also written to frame captures as is, so they only hold fixed size fields.
+
+// View parameters the pipeline selects LODs with, see LODSelector::select.
+struct FrameCamera {
+	DirectX::XMFLOAT3 position;
+	float projYY = 1.0f;
+	float viewportHeight = 0.0f;
+};
+
+// Where one LOD of a chain lives in its index buffer.
+struct LODRange {
+	float error = 0.0f;
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+};
+
+struct SceneChange {
+	enum Type : uint32_t {
+		AddInstance,
+		RemoveInstance,
+		MoveInstance
+	};
+
+	uint32_t type = AddInstance;
+	uint32_t instance = 0;
+	uint32_t chain = 0;
+	DirectX::XMFLOAT3 center;
+	float radius = 0.0f;
+	// LOD an added instance starts at. Selection depends on the previous LOD through hysteresis,
+	// so captures record it to replay the same LODs as the recorded session.
+	uint32_t lod = 0;
+};
+
+// A draw of one instance, the ids refer to resources registered with the RenderContext.
+struct DrawSubmission {
+	uint32_t instance = 0;
+	uint16_t vertexBuffer = 0;
+	uint16_t indexBuffer = 0;
+	uint16_t inputLayout = 0;
+	uint16_t vertexShader = 0;
+	uint16_t pixelShader = 0;
+	uint16_t reserved = 0;
+};
+
+// Draws persist across frames, only additions and removals are submitted.
+struct DrawChange {
+	enum Type : uint32_t {
+		AddDraw,
+		RemoveDraw
+	};
+
+	uint32_t type = AddDraw;
+	uint32_t draw = 0;
+	DrawSubmission submission;
+};
+
+static_assert(sizeof(FrameCamera) == 20, "FrameCamera must stay tightly packed for the capture format.");
+static_assert(sizeof(LODRange) == 12, "LODRange must stay tightly packed for the capture format.");
+static_assert(sizeof(SceneChange) == 32, "SceneChange must stay tightly packed for the capture format.");
+static_assert(sizeof(DrawSubmission) == 16, "DrawSubmission must stay tightly packed for the capture format.");
+static_assert(sizeof(DrawChange) == 24, "DrawChange must stay tightly packed for the capture format.");
+
+// What the pipeline submits to. The renderer implements it on the D3D11 device context and
+// replays implement it as a null device.
+class RenderContext
+{
+public:
+	virtual ~RenderContext() {}
+
+	virtual void set_input_layout(uint16_t inputLayout) = 0;
+	virtual void set_vertex_shader(uint16_t vertexShader) = 0;
+	virtual void set_pixel_shader(uint16_t pixelShader) = 0;
+	virtual void set_vertex_buffer(uint16_t vertexBuffer) = 0;
+	virtual void set_index_buffer(uint16_t indexBuffer) = 0;
+	virtual void draw_indexed(uint32_t indexCount, uint32_t firstIndex) = 0;
+};
+
+struct SubmitStats {
+	uint64_t stateChanges = 0;
+	uint64_t drawCalls = 0;
+};
+
+// Keeps items for sparse ids in a dense array, removals move the last item into the hole.
+template<typename T>
+class DenseIdTable
+{
+private:
+	enum : uint32_t { Empty = UINT32_MAX };
+
+	std::vector<T> _items;
+	std::vector<uint32_t> _ids;
+	std::vector<uint32_t> _slots;
+
+public:
+	bool contains(uint32_t id) const { return id < _slots.size() && _slots[id] != Empty; }
+
+	T* find(uint32_t id) { return contains(id) ? &_items[_slots[id]] : nullptr; }
+	const T* find(uint32_t id) const { return contains(id) ? &_items[_slots[id]] : nullptr; }
+
+	// Inserts or replaces the item for the id.
+	bool insert(uint32_t id, const T& item) {
+		if (id >= MaxPipelineId)
+			return false;
+
+		if (contains(id)) {
+			_items[_slots[id]] = item;
+			return true;
+		}
+
+		if (id >= _slots.size())
+			_slots.resize(id + 1, Empty);
+		_slots[id] = uint32_t(_items.size());
+		_items.push_back(item);
+		_ids.push_back(id);
+		return true;
+	}
+
+	bool erase(uint32_t id) {
+		if (!contains(id))
+			return false;
+
+		uint32_t slot = _slots[id];
+		uint32_t last = uint32_t(_items.size() - 1);
+		_items[slot] = _items[last];
+		_ids[slot] = _ids[last];
+		_slots[_ids[slot]] = slot;
+		_items.pop_back();
+		_ids.pop_back();
+		_slots[id] = Empty;
+		return true;
+	}
+
+	// Removes every item but keeps the allocated storage.
+	void clear() {
+		for (uint32_t id : _ids)
+			_slots[id] = Empty;
+		_items.clear();
+		_ids.clear();
+	}
+
+	std::vector<T>& get_items() { return _items; }
+	const std::vector<T>& get_items() const { return _items; }
+	const std::vector<uint32_t>& get_ids() const { return _ids; }
+};
+
+// The CPU side of a frame: scene updates, LOD selection, draw sorting and submission.
+// The renderer runs it every frame and replays run the same stages from a capture.
+class FramePipeline
+{
+private:
+	struct QueuedDraw {
+		// Shaders and input layout are the most expensive to switch, so they sort first.
+		uint64_t stateKey;
+		uint64_t bufferKey;
+		// Copied rather than pointed to, so draw changes between sort_draws and submit are safe.
+		DrawSubmission draw;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+
+		bool operator<(const QueuedDraw& other) const {
+			return stateKey != other.stateKey ? stateKey < other.stateKey : bufferKey < other.bufferKey;
+		}
+	};
+
+	LODSelector _selector;
+	std::vector<std::vector<LODRange>> _chains;
+	DenseIdTable<LODInstance> _instances;
+	DenseIdTable<DrawSubmission> _draws;
+	std::vector<QueuedDraw> _drawQueue;
+	FrameCamera _camera;
+	SubmitStats _stats;
+
+	FrameCapture* _capture = nullptr;
+
+public:
+	// Registers a LOD chain whose LODs were appended to an index buffer in order, starting at firstIndex.
+	uint32_t add_chain(const LODChain& chain, uint32_t firstIndex);
+	uint32_t add_chain(const std::vector<LODRange>& lods);
+
+	// Both return false and are not recorded if the change refers to an unknown chain, instance or draw.
+	bool apply_scene_change(const SceneChange& change);
+	bool apply_draw_change(const DrawChange& change);
+	// Removes every instance and draw, chains stay registered.
+	void clear_scene();
+
+	void begin_frame(const FrameCamera& camera);
+	void select_lods();
+	void sort_draws();
+	void submit(RenderContext& context);
+
+	// Counts of the last submit.
+	const SubmitStats& get_submit_stats() const { return _stats; }
+
+	// Records every chain and the current scene into the capture, then every change and frame
+	// until stop_capture is called.
+	void start_capture(FrameCapture* capture);
+	void stop_capture() { _capture = nullptr; }
+};
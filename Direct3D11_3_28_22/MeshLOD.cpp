@@ -0,0 +1,358 @@
+#include "MeshLOD.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+using DirectX::XMFLOAT3;
+
+// Boundary edges get an extra plane perpendicular to their face so open borders don't shrink.
+static const double BoundaryWeight = 10.0;
+
+// Symmetric 4x4 matrix of the sum of squared distances to a set of planes. The total plane
+// weight is kept alongside so the sum can be turned back into a distance.
+struct Quadric {
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+    double b2 = 0.0, bc = 0.0, bd = 0.0;
+    double c2 = 0.0, cd = 0.0;
+    double d2 = 0.0;
+    double weight = 0.0;
+
+    void add_plane(double a, double b, double c, double d, double weight) {
+        a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+        b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+        c2 += weight * c * c; cd += weight * c * d;
+        d2 += weight * d * d;
+        this->weight += weight;
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+        return *this;
+    }
+
+    double evaluate(const XMFLOAT3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+             + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+             + c2 * z * z + 2.0 * cd * z
+             + d2;
+    }
+
+    // Weighted mean squared distance of the point to the planes, in object space units squared.
+    double mean_error(const XMFLOAT3& p) const {
+        return weight > 0.0 ? std::max(evaluate(p), 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t fromVersion;
+    uint32_t toVersion;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+static XMFLOAT3 subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+    return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static XMFLOAT3 cross(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+    return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static float dot(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static XMFLOAT3 triangle_normal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+{
+    return cross(subtract(p1, p0), subtract(p2, p0));
+}
+
+static uint64_t edge_key(uint32_t a, uint32_t b)
+{
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+std::vector<uint32_t> simplify_mesh(const XMFLOAT3* positions, size_t vertexCount, size_t vertexStride,
+    const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float* resultError)
+{
+    if (resultError != nullptr)
+        *resultError = 0.0f;
+
+    if (indices.size() % 3 != 0 || targetIndexCount >= indices.size())
+        return indices;
+    for (uint32_t index : indices) {
+        if (index >= vertexCount)
+            return indices;
+    }
+
+    // Pull the positions out of the interleaved vertex data.
+    std::vector<XMFLOAT3> points(vertexCount);
+    const uint8_t* positionBytes = reinterpret_cast<const uint8_t*>(positions);
+    for (size_t i = 0; i < vertexCount; i++)
+        points[i] = *reinterpret_cast<const XMFLOAT3*>(positionBytes + i * vertexStride);
+
+    std::vector<uint32_t> triangles = indices;
+    size_t triangleCount = triangles.size() / 3;
+    std::vector<uint8_t> triangleAlive(triangleCount, 1);
+
+    // Accumulate the plane of every face into its vertices and build vertex to triangle adjacency.
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(triangles.size());
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* tri = &triangles[t * 3];
+        XMFLOAT3 normal = triangle_normal(points[tri[0]], points[tri[1]], points[tri[2]]);
+        float length = std::sqrt(dot(normal, normal));
+        if (length > 0.0f) {
+            double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+            double d = -(a * points[tri[0]].x + b * points[tri[0]].y + c * points[tri[0]].z);
+            for (int i = 0; i < 3; i++)
+                quadrics[tri[i]].add_plane(a, b, c, d, 1.0);
+        }
+
+        for (int i = 0; i < 3; i++) {
+            vertexTriangles[tri[i]].push_back(uint32_t(t));
+            edgeUses[edge_key(tri[i], tri[(i + 1) % 3])]++;
+        }
+    }
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* tri = &triangles[t * 3];
+        XMFLOAT3 normal = triangle_normal(points[tri[0]], points[tri[1]], points[tri[2]]);
+
+        for (int i = 0; i < 3; i++) {
+            uint32_t v0 = tri[i], v1 = tri[(i + 1) % 3];
+            if (edgeUses[edge_key(v0, v1)] != 1)
+                continue;
+
+            XMFLOAT3 edgeNormal = cross(subtract(points[v1], points[v0]), normal);
+            float length = std::sqrt(dot(edgeNormal, edgeNormal));
+            if (length <= 0.0f)
+                continue;
+
+            double a = edgeNormal.x / length, b = edgeNormal.y / length, c = edgeNormal.z / length;
+            double d = -(a * points[v0].x + b * points[v0].y + c * points[v0].z);
+            quadrics[v0].add_plane(a, b, c, d, BoundaryWeight);
+            quadrics[v1].add_plane(a, b, c, d, BoundaryWeight);
+        }
+    }
+
+    std::vector<uint32_t> versions(vertexCount, 0);
+    std::vector<uint8_t> vertexAlive(vertexCount, 1);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses;
+
+    // Queues both directions of an edge, rejected collapses fall back to the other direction.
+    auto queue_edge = [&](uint32_t a, uint32_t b) {
+        Quadric combined = quadrics[a];
+        combined += quadrics[b];
+        collapses.push({ combined.mean_error(points[b]), a, b, versions[a], versions[b] });
+        collapses.push({ combined.mean_error(points[a]), b, a, versions[b], versions[a] });
+    };
+
+    for (const auto& edge : edgeUses)
+        queue_edge(uint32_t(edge.first >> 32), uint32_t(edge.first & 0xFFFFFFFF));
+
+    double maxCost = double(maxError) * double(maxError);
+    double worstCost = 0.0;
+    size_t liveIndexCount = triangles.size();
+
+    while (liveIndexCount > targetIndexCount && !collapses.empty()) {
+        Collapse collapse = collapses.top();
+        collapses.pop();
+
+        uint32_t from = collapse.from, to = collapse.to;
+        if (!vertexAlive[from] || !vertexAlive[to] || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion)
+            continue;
+
+        // Every remaining valid collapse costs at least as much as this one.
+        if (collapse.cost > maxCost)
+            break;
+
+        // Reject the collapse if moving the vertex would flip any of the surviving faces.
+        bool flips = false;
+        for (uint32_t t : vertexTriangles[from]) {
+            uint32_t* tri = &triangles[t * 3];
+            if (!triangleAlive[t] || tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+
+            XMFLOAT3 corners[3] = { points[tri[0]], points[tri[1]], points[tri[2]] };
+            XMFLOAT3 before = triangle_normal(corners[0], corners[1], corners[2]);
+            for (int i = 0; i < 3; i++) {
+                if (tri[i] == from)
+                    corners[i] = points[to];
+            }
+            XMFLOAT3 after = triangle_normal(corners[0], corners[1], corners[2]);
+
+            if (dot(before, after) <= 0.0f) {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        // Collapse the edge, faces sharing it become degenerate and are removed.
+        for (uint32_t t : vertexTriangles[from]) {
+            if (!triangleAlive[t])
+                continue;
+
+            uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                triangleAlive[t] = 0;
+                liveIndexCount -= 3;
+                continue;
+            }
+
+            for (int i = 0; i < 3; i++) {
+                if (tri[i] == from)
+                    tri[i] = to;
+            }
+            vertexTriangles[to].push_back(t);
+        }
+
+        vertexAlive[from] = 0;
+        vertexTriangles[from].clear();
+        quadrics[to] += quadrics[from];
+        versions[to]++;
+        worstCost = std::max(worstCost, collapse.cost);
+
+        // Drop dead faces from the surviving vertex and requeue its edges with the merged quadric.
+        std::vector<uint32_t>& adjacent = vertexTriangles[to];
+        adjacent.erase(std::remove_if(adjacent.begin(), adjacent.end(), [&](uint32_t t) { return !triangleAlive[t]; }), adjacent.end());
+        std::sort(adjacent.begin(), adjacent.end());
+        adjacent.erase(std::unique(adjacent.begin(), adjacent.end()), adjacent.end());
+
+        for (uint32_t t : adjacent) {
+            const uint32_t* tri = &triangles[t * 3];
+            for (int i = 0; i < 3; i++) {
+                if (tri[i] != to)
+                    queue_edge(to, tri[i]);
+            }
+        }
+    }
+
+    std::vector<uint32_t> simplified;
+    simplified.reserve(liveIndexCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (triangleAlive[t])
+            simplified.insert(simplified.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+    }
+
+    if (resultError != nullptr)
+        *resultError = float(std::sqrt(worstCost));
+
+    return simplified;
+}
+
+LODChain generate_lod_chain(const XMFLOAT3* positions, size_t vertexCount, size_t vertexStride,
+    const std::vector<uint32_t>& indices, const LODSettings& settings)
+{
+    LODChain chain;
+    chain.push_back({ indices, 0.0f });
+
+    while (chain.size() < settings.maxLODs) {
+        const MeshLOD& previous = chain.back();
+        size_t previousTriangles = previous.indices.size() / 3;
+        size_t targetTriangles = size_t(float(previousTriangles) * settings.reductionRatio);
+        if (targetTriangles < settings.minTriangles)
+            break;
+
+        // The error budget is shared by the whole chain since each LOD builds on the last.
+        float stepError = 0.0f;
+        std::vector<uint32_t> simplified = simplify_mesh(positions, vertexCount, vertexStride, previous.indices,
+            targetTriangles * 3, settings.maxError - previous.error, &stepError);
+
+        // Stop once a step can no longer meaningfully reduce the mesh.
+        if (simplified.size() * 20 > previous.indices.size() * 19)
+            break;
+
+        float error = previous.error + stepError;
+        chain.push_back({ std::move(simplified), error });
+    }
+
+    return chain;
+}
+
+uint32_t LODSelector::add_chain(const LODChain& chain)
+{
+    std::vector<float> errors;
+    errors.reserve(chain.size());
+    for (const MeshLOD& lod : chain)
+        errors.push_back(lod.error);
+
+    return add_chain(errors);
+}
+
+uint32_t LODSelector::add_chain(const std::vector<float>& errors)
+{
+    ChainRange range;
+    range.first = uint32_t(_errors.size());
+    range.count = uint32_t(errors.size());
+
+    // Selection walks the errors in order, so force them to never decrease.
+    float previousError = 0.0f;
+    for (float error : errors) {
+        previousError = std::max(previousError, error);
+        _errors.push_back(previousError);
+    }
+
+    _chains.push_back(range);
+    return uint32_t(_chains.size() - 1);
+}
+
+void LODSelector::select(const XMFLOAT3& cameraPosition, float projYY, float viewportHeight, LODInstance* instances, size_t instanceCount) const
+{
+    // Object space error times this over the distance gives the error in pixels. Comparisons are
+    // done against threshold * distance instead to keep the division out of the loop.
+    float pixelScale = projYY * viewportHeight * 0.5f;
+    float coarsenBelow = _pixelThreshold * (1.0f - _hysteresis);
+    float refineAbove = _pixelThreshold * (1.0f + _hysteresis);
+
+    const float* errors = _errors.data();
+    const ChainRange* chains = _chains.data();
+
+    for (size_t i = 0; i < instanceCount; i++) {
+        LODInstance& instance = instances[i];
+        assert(instance.chain < _chains.size());
+        const ChainRange& range = chains[instance.chain];
+
+        float dx = instance.center.x - cameraPosition.x;
+        float dy = instance.center.y - cameraPosition.y;
+        float dz = instance.center.z - cameraPosition.z;
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - instance.radius;
+
+        // Use full detail when the camera is inside the bounds.
+        if (distance <= 0.0f || range.count == 0) {
+            instance.lod = 0;
+            continue;
+        }
+
+        const float* chainErrors = errors + range.first;
+        float coarsenLimit = coarsenBelow * distance;
+        float refineLimit = refineAbove * distance;
+
+        uint32_t lod = std::min(instance.lod, range.count - 1);
+        while (lod + 1 < range.count && chainErrors[lod + 1] * pixelScale <= coarsenLimit)
+            lod++;
+        while (lod > 0 && chainErrors[lod] * pixelScale > refineLimit)
+            lod--;
+
+        instance.lod = lod;
+    }
+}
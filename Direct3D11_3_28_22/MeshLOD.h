@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+// A single level of detail. Every LOD of a mesh indexes into the same vertex buffer,
+// only the index list changes. The error is an object space estimate of how far the LOD deviates
+// from the full resolution mesh: the root mean square distance of the collapsed vertices to the
+// original planes around them, weighted by plane area. It is an average, not a bound, and the
+// worst case deviation can be about twice as large.
+struct MeshLOD {
+	std::vector<uint32_t> indices;
+	float error = 0.0f;
+};
+
+typedef std::vector<MeshLOD> LODChain;
+
+struct LODSettings {
+	// Each LOD targets this fraction of the previous LOD's triangle count.
+	float reductionRatio = 0.5f;
+	// Generation stops once a LOD would fall below this many triangles.
+	uint32_t minTriangles = 64;
+	uint32_t maxLODs = 8;
+	// Collapses that would move the surface further than this object space distance are rejected.
+	float maxError = 1e30f;
+};
+
+// Simplifies a triangle list using quadric error metric half edge collapses. Vertices are only
+// ever moved onto other existing vertices, so the returned indices reference the original vertex
+// buffer. Positions are read with a byte stride so any vertex struct can be passed in directly.
+// Returns the input indices if they are malformed or cannot be reduced any further.
+std::vector<uint32_t> simplify_mesh(const DirectX::XMFLOAT3* positions, size_t vertexCount, size_t vertexStride,
+	const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float* resultError = nullptr);
+
+// Generates a LOD chain at import time. LOD 0 is always the unmodified input.
+LODChain generate_lod_chain(const DirectX::XMFLOAT3* positions, size_t vertexCount, size_t vertexStride,
+	const std::vector<uint32_t>& indices, const LODSettings& settings = LODSettings());
+
+// Per instance state used for LOD selection. The bounding sphere is in world space.
+struct LODInstance {
+	DirectX::XMFLOAT3 center;
+	float radius = 0.0f;
+	uint32_t chain = 0;
+	uint32_t lod = 0;
+};
+
+// Picks a LOD per instance from the projected screen space error of each LOD.
+class LODSelector
+{
+private:
+	// Per chain LOD errors, flattened so the selection loop does not chase LODChain vectors.
+	std::vector<float> _errors;
+	struct ChainRange {
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+	std::vector<ChainRange> _chains;
+
+	// Compared against the projected MeshLOD::error, which is an RMS estimate rather than a bound,
+	// so the worst case on screen can be about twice this many pixels.
+	float _pixelThreshold = 1.0f;
+	// Fraction of the threshold a LOD's error has to cross before switching, prevents popping.
+	float _hysteresis = 0.25f;
+
+public:
+	LODSelector(float pixelThreshold = 1.0f, float hysteresis = 0.25f) : _pixelThreshold(pixelThreshold), _hysteresis(hysteresis) {}
+
+	// Registers a chain and returns the index to store in LODInstance::chain.
+	uint32_t add_chain(const LODChain& chain);
+	uint32_t add_chain(const std::vector<float>& errors);
+
+	// Updates LODInstance::lod for every instance. projYY is the [1][1] element of the projection
+	// matrix (cot(fovY / 2)) and viewportHeight is in pixels. Every instance's chain must be an
+	// index returned by add_chain, callers are expected to validate chains when adding instances.
+	void select(const DirectX::XMFLOAT3& cameraPosition, float projYY, float viewportHeight, LODInstance* instances, size_t instanceCount) const;
+};
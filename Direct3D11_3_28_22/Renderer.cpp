@@ -360,25 +360,68 @@ bool Renderer::init()
         return false;
     }
 
-    std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5, 0, 5, 6, 0, 6, 7, 0, 7, 8, 0, 8, 1 };
+    // Two clockwise triangles per face of the cube.
+    std::vector<uint32_t> indices = {
+        0, 1, 2, 0, 2, 3, // Front
+        4, 6, 5, 4, 7, 6, // Back
+        4, 5, 1, 4, 1, 0, // Left
+        3, 2, 6, 3, 6, 7, // Right
+        1, 5, 6, 1, 6, 2, // Top
+        4, 0, 3, 4, 3, 7  // Bottom
+    };
+
+    // Generate the LOD chain at import, every LOD is appended to the same index buffer.
+    LODChain lodChain = generate_lod_chain(&vertices[0].position, vertices.size(), sizeof(StaticVertices), indices);
+    std::vector<uint32_t> lodIndices;
+    for (const MeshLOD& lod : lodChain)
+        lodIndices.insert(lodIndices.end(), lod.indices.begin(), lod.indices.end());
 
     D3D11_BUFFER_DESC indexBufferDesc = {};
-    indexBufferDesc.ByteWidth = sizeof(uint32_t) * indices.size();
+    indexBufferDesc.ByteWidth = sizeof(uint32_t) * lodIndices.size();
     indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 
     D3D11_SUBRESOURCE_DATA indexBufferSubResource = {};
-    indexBufferSubResource.pSysMem = indices.data();
+    indexBufferSubResource.pSysMem = lodIndices.data();
 
     if (FAILED(_device->CreateBuffer(&indexBufferDesc, &indexBufferSubResource, &_indexBuffer))) {
         std::cout << "D3D11 Error: Failed to create index buffer.\n";
         return false;
     }
 
+    // Register the resources with the frame pipeline, their index in each list is their id.
+    _renderContext.set_device_context(_context);
+    _renderContext.inputLayouts.push_back(_shaders.inputLayouts.staticVertices);
+    _renderContext.vertexShaders.push_back(_shaders.vertexShaders.staticVertexShader);
+    _renderContext.vertexBuffers.push_back({ _vertexBuffer, sizeof(StaticVertices) });
+    _renderContext.indexBuffers.push_back(_indexBuffer);
+
+    SceneChange cube;
+    cube.type = SceneChange::AddInstance;
+    cube.instance = 0;
+    cube.chain = _pipeline.add_chain(lodChain, 0);
+    cube.center = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    cube.radius = 1.7320508f;
+    _pipeline.apply_scene_change(cube);
+
+    DrawChange cubeDraw;
+    cubeDraw.type = DrawChange::AddDraw;
+    cubeDraw.draw = 0;
+    cubeDraw.submission.instance = cube.instance;
+    _pipeline.apply_draw_change(cubeDraw);
+
     return true;
 }
 
-void Renderer::draw()
+void Renderer::set_capture(FrameCapture* capture)
+{
+    if (capture != nullptr)
+        _pipeline.start_capture(capture);
+    else
+        _pipeline.stop_capture();
+}
+
+void Renderer::draw(const Camera& camera)
 {
     _context->OMSetRenderTargets(1, _swapchain.backBuffer.RTV.GetAddressOf(), _gBuffer.depthBuffer.DSV.Get());
     _context->OMSetDepthStencilState(_depthStencilState.Get(), 0);
@@ -396,20 +439,53 @@ void Renderer::draw()
     viewport.MaxDepth = 1.0f;
     
     _context->RSSetViewports(1, &viewport);
-
-    _context->IASetInputLayout(_shaders.inputLayouts.staticVertices.Get());
-
-    uint32_t stride = sizeof(StaticVertices), offset = 0;
-    _context->IASetVertexBuffers(0, 1, _vertexBuffer.GetAddressOf(), &stride, &offset);
     _context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    _context->VSSetShader(_shaders.vertexShaders.staticVertexShader.Get(), nullptr, 0);
-    _context->PSSetShader(_pixelShader.Get(), nullptr, 0);
 
-    _context->Draw(3, 0);
+    _pipeline.begin_frame(camera.get_frame_camera(viewport.Height));
+    _pipeline.select_lods();
+    _pipeline.sort_draws();
+    _pipeline.submit(_renderContext);
 
     _swapchain.swapchain->Present(0, 0);
 }
 
+void D3D11RenderContext::set_input_layout(uint16_t inputLayout)
+{
+    _context->IASetInputLayout(inputLayout < inputLayouts.size() ? inputLayouts[inputLayout].Get() : nullptr);
+}
+
+void D3D11RenderContext::set_vertex_shader(uint16_t vertexShader)
+{
+    _context->VSSetShader(vertexShader < vertexShaders.size() ? vertexShaders[vertexShader].Get() : nullptr, nullptr, 0);
+}
+
+void D3D11RenderContext::set_pixel_shader(uint16_t pixelShader)
+{
+    _context->PSSetShader(pixelShader < pixelShaders.size() ? pixelShaders[pixelShader].Get() : nullptr, nullptr, 0);
+}
+
+void D3D11RenderContext::set_vertex_buffer(uint16_t vertexBuffer)
+{
+    ID3D11Buffer* buffer = nullptr;
+    uint32_t stride = 0, offset = 0;
+    if (vertexBuffer < vertexBuffers.size()) {
+        buffer = vertexBuffers[vertexBuffer].buffer.Get();
+        stride = vertexBuffers[vertexBuffer].stride;
+    }
+
+    _context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+}
+
+void D3D11RenderContext::set_index_buffer(uint16_t indexBuffer)
+{
+    _context->IASetIndexBuffer(indexBuffer < indexBuffers.size() ? indexBuffers[indexBuffer].Get() : nullptr, DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D11RenderContext::draw_indexed(uint32_t indexCount, uint32_t firstIndex)
+{
+    _context->DrawIndexed(indexCount, firstIndex, 0);
+}
+
 VertexInputLayout StaticVertices::get_layout()
 {
     VertexInputLayout inputLayoutDesc = {
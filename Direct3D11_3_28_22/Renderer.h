@@ -17,6 +17,9 @@ using Microsoft::WRL::ComPtr;
 
 #include <SimpleMath.h>
 
+#include "Camera.h"
+#include "FramePipeline.h"
+
 typedef std::vector<byte> ShaderByteCode;
 typedef std::vector<D3D11_INPUT_ELEMENT_DESC> VertexInputLayout;
 
@@ -41,6 +44,35 @@ struct DepthBuffer {
 	ComPtr<ID3D11ShaderResourceView> SRV = nullptr;
 };
 
+// Binds the resources the frame pipeline refers to by id on the D3D11 device context.
+class D3D11RenderContext : public RenderContext
+{
+private:
+	ComPtr<ID3D11DeviceContext4> _context = nullptr;
+
+public:
+	struct VertexBufferBinding {
+		ComPtr<ID3D11Buffer> buffer = nullptr;
+		uint32_t stride = 0;
+	};
+
+	// Indexed by the ids in DrawSubmission, unknown ids bind nothing.
+	std::vector<ComPtr<ID3D11InputLayout>> inputLayouts;
+	std::vector<ComPtr<ID3D11VertexShader>> vertexShaders;
+	std::vector<ComPtr<ID3D11PixelShader>> pixelShaders;
+	std::vector<VertexBufferBinding> vertexBuffers;
+	std::vector<ComPtr<ID3D11Buffer>> indexBuffers;
+
+	void set_device_context(const ComPtr<ID3D11DeviceContext4>& context) { _context = context; }
+
+	void set_input_layout(uint16_t inputLayout) override;
+	void set_vertex_shader(uint16_t vertexShader) override;
+	void set_pixel_shader(uint16_t pixelShader) override;
+	void set_vertex_buffer(uint16_t vertexBuffer) override;
+	void set_index_buffer(uint16_t indexBuffer) override;
+	void draw_indexed(uint32_t indexCount, uint32_t firstIndex) override;
+};
+
 class Renderer
 {
 private:
@@ -89,6 +121,10 @@ private:
 	ComPtr<ID3D11Buffer> _vertexBuffer;
 	ComPtr<ID3D11Buffer> _indexBuffer;
 
+	// Frame pipeline
+	FramePipeline _pipeline;
+	D3D11RenderContext _renderContext;
+
 	// Helper functions
 	ShaderByteCode load_compiled_shader(const char* shaderPath);
 	
@@ -106,6 +142,9 @@ public:
 	bool init();
 	void shutdown();
 
-	void draw();
+	// Records frames into the capture until called with nullptr.
+	void set_capture(FrameCapture* capture);
+
+	void draw(const Camera& camera);
 };
 